@@ -0,0 +1,176 @@
+// Copyright 2025 Maksym Paziuk and contributors
+// Released under the MIT license https://opensource.org/license/MIT/
+
+#include "CMAA2PipelineState.h"
+#include "CMAA2Plugin.h"
+#include "RenderGraphUtils.h"
+#include "RenderUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCMAA2, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pipeline State Rebuilds"), STAT_CMAA2_PipelineStateRebuilds, STATGROUP_CMAA2);
+
+// Utils for UE 4.27
+#if CMAA2_UE_VERSION_OLDER_THAN(5, 0)
+bool IsFloatFormat(EPixelFormat Format)
+{
+	switch (Format)
+	{
+	case PF_A32B32G32R32F:
+	case PF_FloatR11G11B10:
+	case PF_FloatRGB:
+	case PF_FloatRGBA:
+	case PF_G16R16F_FILTER:
+	case PF_G16R16F:
+	case PF_G32R32F:
+	case PF_R16F_FILTER:
+	case PF_R16F:
+	case PF_R16G16B16A16_SNORM:
+	case PF_R16G16B16A16_UNORM:
+	case PF_R32_FLOAT:
+	case PF_R5G6B5_UNORM:
+	case PF_R8G8B8A8_SNORM:
+		return true;
+	default:
+		return false;
+	}
+}
+#endif
+
+
+bool CMAA2::SupportsTypedUAVStore(EPixelFormat Format)
+{
+#if CMAA2_UE_VERSION_NEWER_THAN(4,27)
+	return int(GPixelFormats[Format].Capabilities & EPixelFormatCapabilities::TypedUAVStore) != 0;
+#else
+	// Known formats that support typed UAVs in UE 4.27
+	return Format == PF_R32_FLOAT ||
+		Format == PF_R16F ||
+		Format == PF_R32_UINT ||
+		Format == PF_FloatRGBA ||
+		Format == PF_B8G8R8A8 ||
+		Format == PF_R8G8B8A8 ||
+		Format == PF_A2B10G10R10;
+#endif
+}
+
+bool CMAA2::ResolveUAVStoreConfig(EPixelFormat Format, bool bIsSRGB, bool bTypedUAVStore, FUAVStoreConfig& OutConfig)
+{
+	OutConfig = FUAVStoreConfig();
+
+	if (bTypedUAVStore)
+	{
+		OutConfig.bTyped = true;
+		OutConfig.bTypedUnormFloat = !IsFloatFormat(Format);
+		return true;
+	}
+
+	// Fall back to untyped UAV with manual packing
+	OutConfig.bConvertToSRGB = bIsSRGB;
+
+	if (Format == PF_B8G8R8A8 || Format == PF_R8G8B8A8)
+	{
+		OutConfig.UntypedFormat = 1;
+		return true;
+	}
+	if (Format == PF_A2B10G10R10)
+	{
+		OutConfig.UntypedFormat = 2;
+		return true;
+	}
+	return false;
+}
+
+void CMAA2::BuildPipelineState(FPipelineState& State, const FPipelineStateKey& Key)
+{
+	INC_DWORD_STAT(STAT_CMAA2_PipelineStateRebuilds);
+
+	State = FPipelineState();
+	State.Key = Key;
+
+	State.bSupported = ResolveUAVStoreConfig(Key.Format, Key.bIsSRGB, SupportsTypedUAVStore(Key.Format), State.UAVStore);
+	if (!State.bSupported)
+	{
+		// Log once per format rather than once per view or per rebuild
+		static bool bLoggedFormats[PF_MAX] = {};
+		if (!bLoggedFormats[Key.Format])
+		{
+			bLoggedFormats[Key.Format] = true;
+			UE_LOG(LogCMAA2, Warning, TEXT("Scene color format %s%s can not be written by CMAA2, the pass is skipped."), GPixelFormats[Key.Format].Name, Key.bIsSRGB ? TEXT(" (sRGB)") : TEXT(""));
+		}
+		return;
+	}
+
+	const FIntPoint RenderExtent = Key.Extent;
+
+	State.EdgesDesc = FRDGTextureDesc::Create2D(FIntPoint((RenderExtent.X + 1) / 2, RenderExtent.Y), PF_R8_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV);
+	State.ListHeadsDesc = FRDGTextureDesc::Create2D(FIntPoint((RenderExtent.X + 1) / 2, (RenderExtent.Y + 1) / 2), PF_R32_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV);
+
+	const int32 RequiredCandidatePixels = RenderExtent.X * RenderExtent.Y / 4;
+	State.ShapeCandidatesDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), RequiredCandidatePixels);
+
+	const int32 RequiredDeferredColorApplyBuffer = RenderExtent.X * RenderExtent.Y / 2;
+	State.DeferredBlendItemListDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(FUintVector2), RequiredDeferredColorApplyBuffer);
+
+	const int32 RequiredListHeadsPixels = (RenderExtent.X * RenderExtent.Y + 3) / 6;
+	State.DeferredBlendLocationListDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), RequiredListHeadsPixels);
+
+	State.ControlBufferDesc = FRDGBufferDesc::CreateByteAddressDesc(16 * sizeof(uint32));
+#if CMAA2_UE_VERSION_NEWER_THAN(5, 1)
+	State.IndirectArgsDesc = FRDGBufferDesc::CreateIndirectDesc(4, 128);
+#else
+	State.IndirectArgsDesc = FRDGBufferDesc::CreateIndirectDesc(128);
+#endif
+
+	const int32 csOutputKernelSizeX = 14;
+	const int32 csOutputKernelSizeY = 14;
+	State.EdgesGroupCount = FIntVector(FMath::DivideAndRoundUp(RenderExtent.X, csOutputKernelSizeX * 2), FMath::DivideAndRoundUp(RenderExtent.Y, csOutputKernelSizeY * 2), 1);
+	State.DebugGroupCount = FComputeShaderUtils::GetGroupCount(RenderExtent, FIntPoint(16, 16));
+
+	if (Key.bGenerateQualityMap)
+	{
+		const FIntPoint QualityMapSize = FIntPoint::DivideAndRoundUp(RenderExtent, QualityMapTileSize);
+		State.QualityMapDesc = FRDGTextureDesc::Create2D(QualityMapSize, PF_R8_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV);
+		State.QualityMapGroupCount = FComputeShaderUtils::GetGroupCount(QualityMapSize, FIntPoint(8, 8));
+	}
+}
+
+const CMAA2::FPipelineState& CMAA2::FPipelineStateCache::FindOrBuild(const FPipelineStateKey& Key, uint32 FrameNumber)
+{
+	if (FrameNumber != LastPurgeFrame)
+	{
+		LastPurgeFrame = FrameNumber;
+		for (auto It = States.CreateIterator(); It; ++It)
+		{
+			if (FrameNumber - It.Value().LastUsedFrame > MaxIdleFrames)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	FPipelineState* State = States.Find(Key);
+	if (!State)
+	{
+		if (States.Num() >= MaxCount)
+		{
+			FPipelineStateKey LeastRecentlyUsedKey;
+			uint32 LeastRecentlyUsedFrame = MAX_uint32;
+			for (const TPair<FPipelineStateKey, FPipelineState>& Pair : States)
+			{
+				if (Pair.Value.LastUsedFrame <= LeastRecentlyUsedFrame)
+				{
+					LeastRecentlyUsedKey = Pair.Key;
+					LeastRecentlyUsedFrame = Pair.Value.LastUsedFrame;
+				}
+			}
+			States.Remove(LeastRecentlyUsedKey);
+		}
+
+		State = &States.Add(Key);
+		BuildPipelineState(*State, Key);
+		NumBuilds++;
+	}
+	State->LastUsedFrame = FrameNumber;
+	return *State;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+// Copyright 2025 Maksym Paziuk and contributors
+// Released under the MIT license https://opensource.org/license/MIT/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphResources.h"
+#include "CMAA2Utils.h"
+
+DECLARE_STATS_GROUP(TEXT("CMAA2"), STATGROUP_CMAA2, STATCAT_Advanced);
+
+// Utils for UE 4.27
+#if CMAA2_UE_VERSION_OLDER_THAN(5, 0)
+bool IsFloatFormat(EPixelFormat Format);
+
+struct FUintVector2 {
+	uint32 X;
+	uint32 Y;
+};
+#endif
+
+namespace CMAA2
+{
+	// How CMAA2 writes its output; maps 1:1 to the CMAA2_UAV_STORE_* shader permutations
+	struct FUAVStoreConfig
+	{
+		bool bTyped = false;
+		bool bTypedUnormFloat = false;
+		bool bConvertToSRGB = false;
+		int32 UntypedFormat = 0; // 0=none, 1=R8G8B8A8, 2=R10G10B10A2
+	};
+
+	// Whether the current RHI supports typed UAV stores to Format
+	bool SupportsTypedUAVStore(EPixelFormat Format);
+
+	// Picks the UAV store configuration for the output format; returns false if the format can not be written by CMAA2
+	bool ResolveUAVStoreConfig(EPixelFormat Format, bool bIsSRGB, bool bTypedUAVStore, FUAVStoreConfig& OutConfig);
+
+	// Everything the resolved pipeline state depends on. Per-frame values (e.g. the quality map focus) are not part of it.
+	struct FPipelineStateKey
+	{
+		FIntPoint Extent = FIntPoint::ZeroValue;
+		EPixelFormat Format = PF_Unknown;
+		bool bIsSRGB = false;
+		int32 Quality = 0;
+		bool bExtraSharpness = false;
+		bool bQualityMap = false;
+		bool bGenerateQualityMap = false;
+
+		bool operator==(const FPipelineStateKey& Other) const
+		{
+			return Extent == Other.Extent
+				&& Format == Other.Format
+				&& bIsSRGB == Other.bIsSRGB
+				&& Quality == Other.Quality
+				&& bExtraSharpness == Other.bExtraSharpness
+				&& bQualityMap == Other.bQualityMap
+				&& bGenerateQualityMap == Other.bGenerateQualityMap;
+		}
+
+		bool operator!=(const FPipelineStateKey& Other) const
+		{
+			return !(*this == Other);
+		}
+
+		friend uint32 GetTypeHash(const FPipelineStateKey& Key)
+		{
+			uint32 Hash = GetTypeHash(Key.Extent);
+			Hash = HashCombine(Hash, GetTypeHash(uint32(Key.Format)));
+			Hash = HashCombine(Hash, GetTypeHash(Key.Quality));
+			return HashCombine(Hash, uint32(Key.bIsSRGB) | (uint32(Key.bExtraSharpness) << 1) | (uint32(Key.bQualityMap) << 2) | (uint32(Key.bGenerateQualityMap) << 3));
+		}
+	};
+
+	// Resolved output store, working resource descriptors and dispatch sizes, shared by every view with the same key.
+	// Shaders themselves are looked up per pass as global shader recompiles replace them behind a stable shader map pointer.
+	struct FPipelineState
+	{
+		FPipelineStateKey Key;
+		bool bSupported = false;
+		FUAVStoreConfig UAVStore;
+		uint32 LastUsedFrame = 0;
+
+		FRDGTextureDesc EdgesDesc;
+		FRDGTextureDesc ListHeadsDesc;
+		FRDGTextureDesc QualityMapDesc;
+		FRDGBufferDesc ShapeCandidatesDesc;
+		FRDGBufferDesc DeferredBlendItemListDesc;
+		FRDGBufferDesc DeferredBlendLocationListDesc;
+		FRDGBufferDesc ControlBufferDesc;
+		FRDGBufferDesc IndirectArgsDesc;
+
+		FIntVector EdgesGroupCount = FIntVector::ZeroValue;
+		FIntVector DebugGroupCount = FIntVector::ZeroValue;
+		FIntVector QualityMapGroupCount = FIntVector::ZeroValue;
+	};
+
+	void BuildPipelineState(FPipelineState& State, const FPipelineStateKey& Key);
+
+	// Content keyed pipeline state cache; not thread safe, the renderer uses a single instance from the render thread
+	class FPipelineStateCache
+	{
+	public:
+		// States no view has used for this many frames are dropped
+		static constexpr uint32 MaxIdleFrames = 300;
+		// Upper bound on cached states; the least recently used one is evicted beyond it
+		static constexpr int32 MaxCount = 32;
+
+		// Returns the state for Key, only building it if it is not cached yet
+		const FPipelineState& FindOrBuild(const FPipelineStateKey& Key, uint32 FrameNumber);
+
+		int32 Num() const { return States.Num(); }
+		uint32 GetNumBuilds() const { return NumBuilds; }
+
+	private:
+		TMap<FPipelineStateKey, FPipelineState> States;
+		uint32 LastPurgeFrame = 0;
+		uint32 NumBuilds = 0;
+	};
+}
\ No newline at end of file
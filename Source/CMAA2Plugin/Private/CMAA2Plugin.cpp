@@ -8,6 +8,7 @@
 #include "PostProcess/PostProcessMaterial.h"
 #include "PostProcess/PostProcessing.h"
 #include "SceneViewExtension.h"
+#include "RenderingThread.h"
 
 IMPLEMENT_MODULE(FCMAA2PluginModule, CMAA2Plugin)
 
@@ -19,7 +20,7 @@ IMPLEMENT_MODULE(FCMAA2PluginModule, CMAA2Plugin)
 class FCMAA2ViewExtension : public FSceneViewExtensionBase
 {
 public:
-	FCMAA2ViewExtension(const FAutoRegister& AutoRegister) : FSceneViewExtensionBase(AutoRegister) {}
+	FCMAA2ViewExtension(const FAutoRegister& AutoRegister, const FCMAA2PluginModule& InModule) : FSceneViewExtensionBase(AutoRegister), Module(InModule) {}
 
 	// These are required overrides from the base ISceneViewExtension interface.
 	// We can leave them empty as we only need to hook into the post-processing pass.
@@ -53,7 +54,14 @@ public:
 
 			if (View.AntiAliasingMethod == AAM_None)
 			{
-				CMAA2::AddCMAA2Pass(GraphBuilder, View, SceneColor.Texture);
+				FRDGTextureRef QualityMap = nullptr;
+				const FCMAA2QualityMapProvider& QualityMapProvider = Module.GetQualityMapProvider_RenderThread();
+				if (QualityMapProvider.IsBound())
+				{
+					QualityMap = QualityMapProvider.Execute(GraphBuilder, View);
+				}
+
+				CMAA2::AddCMAA2Pass(GraphBuilder, View, SceneColor.Texture, QualityMap);
 			}
 		}
 	}
@@ -123,6 +131,9 @@ public:
 //			);
 //		}
 //	}
+
+private:
+	const FCMAA2PluginModule& Module;
 };
 
 
@@ -148,5 +159,14 @@ void FCMAA2PluginModule::ShutdownModule()
 
 void FCMAA2PluginModule::InitCMAA2ViewExtension()
 {
-	CMAA2ViewExtension = FSceneViewExtensions::NewExtension<FCMAA2ViewExtension>();
+	CMAA2ViewExtension = FSceneViewExtensions::NewExtension<FCMAA2ViewExtension>(*this);
+}
+
+void FCMAA2PluginModule::SetQualityMapProvider(FCMAA2QualityMapProvider Provider)
+{
+	ENQUEUE_RENDER_COMMAND(CMAA2SetQualityMapProvider)(
+		[this, Provider](FRHICommandListImmediate& RHICmdList)
+		{
+			QualityMapProvider_RenderThread = Provider;
+		});
 }
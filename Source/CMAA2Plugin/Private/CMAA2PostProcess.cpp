@@ -3,6 +3,7 @@
 
 #include "CMAA2PostProcess.h"
 #include "CMAA2Utils.h"
+#include "CMAA2PipelineState.h"
 #include "SceneRendering.h"
 #if CMAA2_UE_VERSION_NEWER_THAN(5, 1)
 	#include "DataDrivenShaderPlatformInfo.h"
@@ -19,34 +20,7 @@
 #if CMAA2_UE_VERSION_OLDER_THAN(5, 0)
 #define SRGB TexCreate_SRGB
 
-bool IsFloatFormat(EPixelFormat Format)
-{
-	switch (Format)
-	{
-	case PF_A32B32G32R32F:
-	case PF_FloatR11G11B10:
-	case PF_FloatRGB:
-	case PF_FloatRGBA:
-	case PF_G16R16F_FILTER:
-	case PF_G16R16F:
-	case PF_G32R32F:
-	case PF_R16F_FILTER:
-	case PF_R16F:
-	case PF_R16G16B16A16_SNORM:
-	case PF_R16G16B16A16_UNORM:
-	case PF_R32_FLOAT:
-	case PF_R5G6B5_UNORM:
-	case PF_R8G8B8A8_SNORM:
-		return true;
-	default:
-		return false;
-	}
-}
-
-struct FUintVector2 {
-	uint32 X;
-	uint32 Y;
-};
+using FVector2f = FVector2D;
 #endif
 
 namespace CMAA2
@@ -78,6 +52,44 @@ namespace CMAA2
 		0,
 		TEXT("Set to 1 to enable debug visualization of detected edges."),
 		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<int32> CVarCMAA2QualityMap(
+		TEXT("r.CMAA2.QualityMap"),
+		0,
+		TEXT("Varies CMAA2 quality per screen tile.\n")
+		TEXT("0: Disabled, r.CMAA2.Quality is used everywhere (default)\n")
+		TEXT("1: Foveated, full r.CMAA2.Quality around r.CMAA2.QualityMap.FocusX/Y, dropping towards r.CMAA2.QualityMap.PeripheralQuality"),
+		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<float> CVarCMAA2QualityMapFocusX(
+		TEXT("r.CMAA2.QualityMap.FocusX"),
+		0.5f,
+		TEXT("Horizontal position of the full quality region, normalized to the view (0: left, 1: right). Can be driven by eye tracking."),
+		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<float> CVarCMAA2QualityMapFocusY(
+		TEXT("r.CMAA2.QualityMap.FocusY"),
+		0.5f,
+		TEXT("Vertical position of the full quality region, normalized to the view (0: top, 1: bottom). Can be driven by eye tracking."),
+		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<float> CVarCMAA2QualityMapInnerRadius(
+		TEXT("r.CMAA2.QualityMap.InnerRadius"),
+		0.4f,
+		TEXT("Radius of the full quality region, relative to half the view height."),
+		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<float> CVarCMAA2QualityMapOuterRadius(
+		TEXT("r.CMAA2.QualityMap.OuterRadius"),
+		1.2f,
+		TEXT("Radius beyond which r.CMAA2.QualityMap.PeripheralQuality is used, relative to half the view height."),
+		ECVF_RenderThreadSafe);
+
+	TAutoConsoleVariable<int32> CVarCMAA2QualityMapPeripheralQuality(
+		TEXT("r.CMAA2.QualityMap.PeripheralQuality"),
+		0,
+		TEXT("Quality preset used in the periphery. 0: LOW, 1: MEDIUM, 2: HIGH, 3: ULTRA."),
+		ECVF_RenderThreadSafe);
 }
 
 
@@ -93,6 +105,7 @@ public:
 	class FUAVStoreUntypedFormatDim : SHADER_PERMUTATION_INT("CMAA2_UAV_STORE_UNTYPED_FORMAT", 3); // 0=none, 1=R8G8B8A8, 2=R10G10B10A2
 	class FHDRDim : SHADER_PERMUTATION_BOOL("CMAA2_SUPPORT_HDR_COLOR_RANGE");
 	class FLumaPathDim : SHADER_PERMUTATION_INT("CMAA2_EDGE_DETECTION_LUMA_PATH", 2); // 0, 1
+	class FQualityMapDim : SHADER_PERMUTATION_BOOL("CMAA2_QUALITY_MAP");
 
 	using FPermutationDomain = TShaderPermutationDomain<
 		FQualityDim,
@@ -102,7 +115,8 @@ public:
 		FUAVStoreConvertToSRGBDim,
 		FUAVStoreUntypedFormatDim,
 		FHDRDim,
-		FLumaPathDim>;
+		FLumaPathDim,
+		FQualityMapDim>;
 
 	FCMAA2Shader() = default;
 	FCMAA2Shader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
@@ -138,6 +152,15 @@ public:
 	{
 		OutEnvironment.SetDefine(TEXT("CMAA_MSAA_SAMPLE_COUNT"), 1);
 		OutEnvironment.SetDefine(TEXT("CMAA2_MAX_LINE_LENGTH"), CMAA2_MAX_LINE_LENGTH);
+		OutEnvironment.SetDefine(TEXT("CMAA2_QUALITY_MAP_TILE_SIZE"), CMAA2::QualityMapTileSize);
+	}
+
+protected:
+	// Only EdgesColor2x2CS and ProcessCandidatesCS read the quality map
+	static bool ShouldCompileWithoutQualityMap(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		return !PermutationVector.Get<FQualityMapDim>() && FCMAA2Shader::ShouldCompilePermutation(Parameters);
 	}
 };
 
@@ -154,6 +177,7 @@ class FCMAA2EdgesColor2x2CS : public FCMAA2Shader
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, g_workingShapeCandidates)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, g_workingDeferredBlendItemListHeads)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWByteAddressBuffer, g_workingControlBuffer)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, g_inQualityMapReadonly)
 	END_SHADER_PARAMETER_STRUCT()
 };
 IMPLEMENT_GLOBAL_SHADER(FCMAA2EdgesColor2x2CS, "/CMAA2Plugin/CMAA2.usf", "EdgesColor2x2CS", SF_Compute);
@@ -172,6 +196,7 @@ class FCMAA2ProcessCandidatesCS : public FCMAA2Shader
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, g_workingDeferredBlendItemListHeads)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint2>, g_workingDeferredBlendItemList)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, g_workingDeferredBlendLocationList)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, g_inQualityMapReadonly)
 #if CMAA2_UE_VERSION_NEWER_THAN(4,27)
 		RDG_BUFFER_ACCESS(IndirectDispatchArgsBuffer, ERHIAccess::IndirectArgs)
 #else
@@ -187,6 +212,11 @@ class FCMAA2DeferredColorApply2x2CS : public FCMAA2Shader
 	DECLARE_GLOBAL_SHADER(FCMAA2DeferredColorApply2x2CS);
 	SHADER_USE_PARAMETER_STRUCT(FCMAA2DeferredColorApply2x2CS, FCMAA2Shader);
 
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return ShouldCompileWithoutQualityMap(Parameters);
+	}
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, g_workingDeferredBlendLocationList)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, g_workingDeferredBlendItemListHeads)
@@ -208,6 +238,11 @@ class FCMAA2ComputeDispatchArgsCS : public FCMAA2Shader
 	DECLARE_GLOBAL_SHADER(FCMAA2ComputeDispatchArgsCS);
 	SHADER_USE_PARAMETER_STRUCT(FCMAA2ComputeDispatchArgsCS, FCMAA2Shader);
 
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return ShouldCompileWithoutQualityMap(Parameters);
+	}
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWByteAddressBuffer, g_workingControlBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWByteAddressBuffer, g_workingExecuteIndirectBuffer)
@@ -223,6 +258,11 @@ class FCMAA2DebugDrawEdgesCS : public FCMAA2Shader
 	DECLARE_GLOBAL_SHADER(FCMAA2DebugDrawEdgesCS);
 	SHADER_USE_PARAMETER_STRUCT(FCMAA2DebugDrawEdgesCS, FCMAA2Shader);
 
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return ShouldCompileWithoutQualityMap(Parameters);
+	}
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, g_workingEdges)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, g_inoutColorWriteonly)
@@ -230,155 +270,123 @@ class FCMAA2DebugDrawEdgesCS : public FCMAA2Shader
 };
 IMPLEMENT_GLOBAL_SHADER(FCMAA2DebugDrawEdgesCS, "/CMAA2Plugin/CMAA2.usf", "DebugDrawEdgesCS", SF_Compute);
 
-
-void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDGTextureRef Output)
+// Shader for generating the foveated quality map; lives in its own file as it shares nothing with the CMAA2 passes
+class FCMAA2GenerateQualityMapCS : public FGlobalShader
 {
-	const FIntPoint RenderExtent = ((FViewInfo&)(View)).ViewRect.Size();
+	DECLARE_GLOBAL_SHADER(FCMAA2GenerateQualityMapCS);
+	SHADER_USE_PARAMETER_STRUCT(FCMAA2GenerateQualityMapCS, FGlobalShader);
 
-	int32 Quality = FMath::Clamp(CVarCMAA2Quality.GetValueOnRenderThread(), 0, 3);
-	RDG_EVENT_SCOPE(GraphBuilder, "CMAA2 %dx%d Quality: %d", RenderExtent.X, RenderExtent.Y, Quality);
-
-	FCMAA2Shader::FPermutationDomain PermutationVector;
-	PermutationVector.Set<FCMAA2Shader::FQualityDim>(Quality);
-	PermutationVector.Set<FCMAA2Shader::FSharpnessDim>(CVarCMAA2ExtraSharpness.GetValueOnRenderThread() != 0);
-	PermutationVector.Set<FCMAA2Shader::FHDRDim>(IsFloatFormat(Output->Desc.Format));
-	PermutationVector.Set<FCMAA2Shader::FLumaPathDim>(1);
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, g_outQualityMap)
+		SHADER_PARAMETER(FIntPoint, g_qualityMapSize)
+		SHADER_PARAMETER(FVector2f, g_qualityMapFocus)
+		SHADER_PARAMETER(float, g_qualityMapInvRadiusScale)
+		SHADER_PARAMETER(FVector2f, g_qualityMapRadii)
+		SHADER_PARAMETER(uint32, g_qualityMapCeilingPreset)
+		SHADER_PARAMETER(uint32, g_qualityMapPeripheralPreset)
+	END_SHADER_PARAMETER_STRUCT()
 
-#if CMAA2_UE_VERSION_NEWER_THAN(4,27)
-	// Determine UAV storage strategy
-	const FPixelFormatInfo& FormatInfo = GPixelFormats[Output->Desc.Format];
-	EPixelFormat NonSRGBFormat = Output->Desc.Format;
-	const FPixelFormatInfo& NonSRGBFormatInfo = GPixelFormats[NonSRGBFormat];
-	bool bIsSRGB = uint64(Output->Desc.Flags & ETextureCreateFlags::SRGB) != 0;
-	EPixelFormat UAVFormat = Output->Desc.Format; // Use the format of our working texture
-
-	if (int(NonSRGBFormatInfo.Capabilities & EPixelFormatCapabilities::TypedUAVStore) != 0)
-	{
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(!IsFloatFormat(UAVFormat));
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(false);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(0);
-	}
-	else if (bIsSRGB && int(NonSRGBFormatInfo.Capabilities & EPixelFormatCapabilities::TypedUAVStore))
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
-		UAVFormat = NonSRGBFormat;
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(!IsFloatFormat(UAVFormat));
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(0);
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
 	}
-	else
-	{
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(false);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(false);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(bIsSRGB);
-		UAVFormat = PF_R32_UINT;
 
-		if (NonSRGBFormat == PF_B8G8R8A8 || NonSRGBFormat == PF_R8G8B8A8)
-		{
-			PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(1);
-		}
-		else if (NonSRGBFormat == PF_A2B10G10R10)
-		{
-			PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(2);
-		}
-		else
-		{
-			return;
-		}
-	}
-#else
-	// Manual format info retrieval
-	EPixelFormat Format = Output->Desc.Format;
-	bool bIsSRGB = EnumHasAnyFlags(Output->Desc.Flags, TexCreate_SRGB);
-
-	// Start with default assumption
-	EPixelFormat UAVFormat = Format;
-
-	// Check for known formats that support typed UAVs in UE 4.27
-	const bool bTypedUAVSupported =
-		Format == PF_R32_FLOAT ||
-		Format == PF_R16F ||
-		Format == PF_R32_UINT ||
-		Format == PF_FloatRGBA ||
-		Format == PF_B8G8R8A8 ||
-		Format == PF_R8G8B8A8 ||
-		Format == PF_A2B10G10R10;
-
-	// Initialize permutation vector
-	PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(false);
-	PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(false);
-	PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(false);
-	PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(0);
-
-	if (bTypedUAVSupported)
-	{
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(!IsFloatFormat(Format));
-	}
-	else if (bIsSRGB &&
-		(Format == PF_B8G8R8A8 || Format == PF_R8G8B8A8) &&
-		// Assume non-SRGB variant of these formats support UAVs
-		true)
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
 	{
-		// Use non-sRGB variant
-		UAVFormat = Format; // Same format, but omit SRGB for UAV
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(true);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(true);
+		OutEnvironment.SetDefine(TEXT("CMAA2_QUALITY_MAP_TILE_SIZE"), CMAA2::QualityMapTileSize);
 	}
-	else
-	{
-		// Fall back to untyped UAV
-		UAVFormat = PF_R32_UINT;
-
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(false);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(false);
-		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(bIsSRGB);
+};
+IMPLEMENT_GLOBAL_SHADER(FCMAA2GenerateQualityMapCS, "/CMAA2Plugin/CMAA2QualityMap.usf", "GenerateQualityMapCS", SF_Compute);
 
-		if (Format == PF_B8G8R8A8 || Format == PF_R8G8B8A8)
-		{
-			PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(1);
-		}
-		else if (Format == PF_A2B10G10R10)
-		{
-			PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(2);
-		}
-		else
-		{
-			// Unsupported fallback
-			return;
-		}
-	}
-#endif
 
-	const int32 EdgesResX = (RenderExtent.X + 1) / 2;
-	FRDGTextureDesc EdgesDesc = FRDGTextureDesc::Create2D(FIntPoint(EdgesResX, RenderExtent.Y), PF_R8_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV);
-	FRDGTextureRef WorkingEdges = GraphBuilder.CreateTexture(EdgesDesc, TEXT("CMAA2.WorkingEdges"));
+DECLARE_CYCLE_STAT(TEXT("AddCMAA2Pass"), STAT_CMAA2_AddPass, STATGROUP_CMAA2);
 
-	FRDGTextureDesc ListHeadsDesc = FRDGTextureDesc::Create2D(FIntPoint((RenderExtent.X + 1) / 2, (RenderExtent.Y + 1) / 2), PF_R32_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV);
-	FRDGTextureRef WorkingDeferredBlendItemListHeads = GraphBuilder.CreateTexture(ListHeadsDesc, TEXT("CMAA2.WorkingDeferredBlendItemListHeads"));
+namespace CMAA2
+{
+	// Render thread only
+	static FPipelineStateCache GPipelineStateCache;
 
-	const int32 RequiredCandidatePixels = RenderExtent.X * RenderExtent.Y / 4;
-	FRDGBufferRef WorkingShapeCandidates = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), RequiredCandidatePixels), TEXT("CMAA2.WorkingShapeCandidates"));
+	static FCMAA2Shader::FPermutationDomain GetPermutationVector(const FPipelineState& State, bool bQualityMap)
+	{
+		FCMAA2Shader::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FCMAA2Shader::FQualityDim>(State.Key.Quality);
+		PermutationVector.Set<FCMAA2Shader::FSharpnessDim>(State.Key.bExtraSharpness);
+		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedDim>(State.UAVStore.bTyped);
+		PermutationVector.Set<FCMAA2Shader::FUAVStoreTypedUnormFloatDim>(State.UAVStore.bTypedUnormFloat);
+		PermutationVector.Set<FCMAA2Shader::FUAVStoreConvertToSRGBDim>(State.UAVStore.bConvertToSRGB);
+		PermutationVector.Set<FCMAA2Shader::FUAVStoreUntypedFormatDim>(State.UAVStore.UntypedFormat);
+		PermutationVector.Set<FCMAA2Shader::FHDRDim>(IsFloatFormat(State.Key.Format));
+		PermutationVector.Set<FCMAA2Shader::FLumaPathDim>(1);
+		PermutationVector.Set<FCMAA2Shader::FQualityMapDim>(bQualityMap);
+		return PermutationVector;
+	}
+}
 
-	const int32 RequiredDeferredColorApplyBuffer = RenderExtent.X * RenderExtent.Y / 2;
-	FRDGBufferRef WorkingDeferredBlendItemList = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(FUintVector2), RequiredDeferredColorApplyBuffer), TEXT("CMAA2.WorkingDeferredBlendItemList"));
 
-	const int32 RequiredListHeadsPixels = (RenderExtent.X * RenderExtent.Y + 3) / 6;
-	FRDGBufferRef WorkingDeferredBlendLocationList = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), RequiredListHeadsPixels), TEXT("CMAA2.WorkingDeferredBlendLocationList"));
+void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDGTextureRef Output, FRDGTextureRef QualityMap)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CMAA2_AddPass);
 
-	FRDGBufferRef WorkingControlBuffer = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateByteAddressDesc(16 * sizeof(uint32)), TEXT("CMAA2.WorkingControlBuffer"));
-#if CMAA2_UE_VERSION_NEWER_THAN(5, 1)
-	FRDGBufferDesc IndirectArgsDesc = FRDGBufferDesc::CreateIndirectDesc(4, 128);
+	FPipelineStateKey Key;
+	Key.Extent = ((FViewInfo&)(View)).ViewRect.Size();
+	Key.Format = Output->Desc.Format;
+#if CMAA2_UE_VERSION_NEWER_THAN(4,27)
+	Key.bIsSRGB = uint64(Output->Desc.Flags & ETextureCreateFlags::SRGB) != 0;
 #else
-	FRDGBufferDesc IndirectArgsDesc = FRDGBufferDesc::CreateIndirectDesc(128);
+	Key.bIsSRGB = EnumHasAnyFlags(Output->Desc.Flags, TexCreate_SRGB);
 #endif
-	FRDGBufferRef WorkingExecuteIndirectBuffer = GraphBuilder.CreateBuffer(IndirectArgsDesc, TEXT("CMAA2.WorkingExecuteIndirectBuffer"));
+	Key.Quality = FMath::Clamp(CVarCMAA2Quality.GetValueOnRenderThread(), 0, 3);
+	Key.bExtraSharpness = CVarCMAA2ExtraSharpness.GetValueOnRenderThread() != 0;
+	Key.bGenerateQualityMap = !QualityMap && CVarCMAA2QualityMap.GetValueOnRenderThread() != 0;
+	Key.bQualityMap = QualityMap != nullptr || Key.bGenerateQualityMap;
+
+	const FPipelineState& State = GPipelineStateCache.FindOrBuild(Key, GFrameNumberRenderThread);
+	if (!State.bSupported)
+	{
+		return;
+	}
+
+	// Only the edge detection and shape processing passes have quality map permutations
+	const FCMAA2Shader::FPermutationDomain PermutationVector = GetPermutationVector(State, false);
+	const FCMAA2Shader::FPermutationDomain QualityMapPermutationVector = GetPermutationVector(State, Key.bQualityMap);
+
+	const FIntPoint RenderExtent = Key.Extent;
+	RDG_EVENT_SCOPE(GraphBuilder, "CMAA2 %dx%d Quality: %d", RenderExtent.X, RenderExtent.Y, Key.Quality);
+
+	FRDGTextureRef WorkingEdges = GraphBuilder.CreateTexture(State.EdgesDesc, TEXT("CMAA2.WorkingEdges"));
+	FRDGTextureRef WorkingDeferredBlendItemListHeads = GraphBuilder.CreateTexture(State.ListHeadsDesc, TEXT("CMAA2.WorkingDeferredBlendItemListHeads"));
+	FRDGBufferRef WorkingShapeCandidates = GraphBuilder.CreateBuffer(State.ShapeCandidatesDesc, TEXT("CMAA2.WorkingShapeCandidates"));
+	FRDGBufferRef WorkingDeferredBlendItemList = GraphBuilder.CreateBuffer(State.DeferredBlendItemListDesc, TEXT("CMAA2.WorkingDeferredBlendItemList"));
+	FRDGBufferRef WorkingDeferredBlendLocationList = GraphBuilder.CreateBuffer(State.DeferredBlendLocationListDesc, TEXT("CMAA2.WorkingDeferredBlendLocationList"));
+	FRDGBufferRef WorkingControlBuffer = GraphBuilder.CreateBuffer(State.ControlBufferDesc, TEXT("CMAA2.WorkingControlBuffer"));
+	FRDGBufferRef WorkingExecuteIndirectBuffer = GraphBuilder.CreateBuffer(State.IndirectArgsDesc, TEXT("CMAA2.WorkingExecuteIndirectBuffer"));
 
 	// Initial clear passes
 	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(WorkingControlBuffer), 0);
 
+	// Optional per-tile quality map. Generated here unless the caller provided one.
+	if (Key.bGenerateQualityMap)
+	{
+		QualityMap = GraphBuilder.CreateTexture(State.QualityMapDesc, TEXT("CMAA2.QualityMap"));
+
+		const float InnerRadius = FMath::Max(CVarCMAA2QualityMapInnerRadius.GetValueOnRenderThread(), 0.0f);
+		const float OuterRadius = FMath::Max(CVarCMAA2QualityMapOuterRadius.GetValueOnRenderThread(), InnerRadius);
+
+		auto* PassParameters = GraphBuilder.AllocParameters<FCMAA2GenerateQualityMapCS::FParameters>();
+		PassParameters->g_outQualityMap = GraphBuilder.CreateUAV(QualityMap);
+		PassParameters->g_qualityMapSize = State.QualityMapDesc.Extent;
+		PassParameters->g_qualityMapFocus = FVector2f(
+			FMath::Clamp(CVarCMAA2QualityMapFocusX.GetValueOnRenderThread(), 0.0f, 1.0f) * RenderExtent.X,
+			FMath::Clamp(CVarCMAA2QualityMapFocusY.GetValueOnRenderThread(), 0.0f, 1.0f) * RenderExtent.Y);
+		PassParameters->g_qualityMapInvRadiusScale = 2.0f / FMath::Max(RenderExtent.Y, 1);
+		PassParameters->g_qualityMapRadii = FVector2f(InnerRadius, OuterRadius);
+		PassParameters->g_qualityMapCeilingPreset = Key.Quality;
+		PassParameters->g_qualityMapPeripheralPreset = FMath::Clamp(CVarCMAA2QualityMapPeripheralQuality.GetValueOnRenderThread(), 0, 3);
+
+		TShaderMapRef<FCMAA2GenerateQualityMapCS> ComputeShader(((FViewInfo&)(View)).ShaderMap);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 GenerateQualityMap"), ComputeShader, PassParameters, State.QualityMapGroupCount);
+	}
+
 	// PASS 1: Edge Detection. This pass populates the shape candidates buffer and increments the counter in the control buffer.
 	{
 		auto* PassParameters = GraphBuilder.AllocParameters<FCMAA2EdgesColor2x2CS::FParameters>();
@@ -392,12 +400,10 @@ void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDG
 		PassParameters->g_workingShapeCandidates = GraphBuilder.CreateUAV(WorkingShapeCandidates);
 		PassParameters->g_workingDeferredBlendItemListHeads = GraphBuilder.CreateUAV(WorkingDeferredBlendItemListHeads);
 		PassParameters->g_workingControlBuffer = GraphBuilder.CreateUAV(WorkingControlBuffer);
+		PassParameters->g_inQualityMapReadonly = QualityMap;
 
-		TShaderMapRef<FCMAA2EdgesColor2x2CS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
-		const int32 csOutputKernelSizeX = 14;
-		const int32 csOutputKernelSizeY = 14;
-		FIntVector GroupCount = FIntVector(FMath::DivideAndRoundUp(RenderExtent.X, csOutputKernelSizeX * 2), FMath::DivideAndRoundUp(RenderExtent.Y, csOutputKernelSizeY * 2), 1);
-		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 EdgesColor2x2"), ComputeShader, PassParameters, GroupCount);
+		TShaderMapRef<FCMAA2EdgesColor2x2CS> ComputeShader(((FViewInfo&)(View)).ShaderMap, QualityMapPermutationVector);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 EdgesColor2x2"), ComputeShader, PassParameters, State.EdgesGroupCount);
 	}
 
 	// PASS 2: Compute Dispatch Arguments for ProcessCandidates. This reads the counter filled by the previous pass.
@@ -407,8 +413,8 @@ void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDG
 		PassParameters->g_workingExecuteIndirectBuffer = GraphBuilder.CreateUAV(WorkingExecuteIndirectBuffer);
 		PassParameters->g_workingShapeCandidates = GraphBuilder.CreateUAV(WorkingShapeCandidates);
 		PassParameters->g_workingDeferredBlendLocationList = GraphBuilder.CreateUAV(WorkingDeferredBlendLocationList);
-		TShaderMapRef<FCMAA2ComputeDispatchArgsCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
 		// Dispatch(2,1,1) triggers the groupID.x == 1 path in the shader to process shape candidates count.
+		TShaderMapRef<FCMAA2ComputeDispatchArgsCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
 		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 ComputeDispatchArgs (Process)"), ComputeShader, PassParameters, FIntVector(2, 1, 1));
 	}
 
@@ -427,8 +433,9 @@ void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDG
 		PassParameters->g_workingDeferredBlendItemListHeads = GraphBuilder.CreateUAV(WorkingDeferredBlendItemListHeads);
 		PassParameters->g_workingDeferredBlendItemList = GraphBuilder.CreateUAV(WorkingDeferredBlendItemList);
 		PassParameters->g_workingDeferredBlendLocationList = GraphBuilder.CreateUAV(WorkingDeferredBlendLocationList);
+		PassParameters->g_inQualityMapReadonly = QualityMap;
 		PassParameters->IndirectDispatchArgsBuffer = WorkingExecuteIndirectBuffer;
-		TShaderMapRef<FCMAA2ProcessCandidatesCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
+		TShaderMapRef<FCMAA2ProcessCandidatesCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, QualityMapPermutationVector);
 		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 ProcessCandidates"), ComputeShader, PassParameters, WorkingExecuteIndirectBuffer, 0);
 	}
 
@@ -439,8 +446,8 @@ void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDG
 		PassParameters->g_workingExecuteIndirectBuffer = GraphBuilder.CreateUAV(WorkingExecuteIndirectBuffer);
 		PassParameters->g_workingShapeCandidates = GraphBuilder.CreateUAV(WorkingShapeCandidates);
 		PassParameters->g_workingDeferredBlendLocationList = GraphBuilder.CreateUAV(WorkingDeferredBlendLocationList);
-		TShaderMapRef<FCMAA2ComputeDispatchArgsCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
 		// Dispatch(1,2,1) triggers the groupID.y == 1 path in the shader to process blend location list count.
+		TShaderMapRef<FCMAA2ComputeDispatchArgsCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
 		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 ComputeDispatchArgs (Apply)"), ComputeShader, PassParameters, FIntVector(1, 2, 1));
 	}
 
@@ -464,6 +471,6 @@ void CMAA2::AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDG
 		PassParameters->g_workingEdges = GraphBuilder.CreateUAV(WorkingEdges);
 		PassParameters->g_inoutColorWriteonly = GraphBuilder.CreateUAV(Output);
 		TShaderMapRef<FCMAA2DebugDrawEdgesCS> ComputeShader(((FViewInfo&)(View)).ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 DebugDrawEdges"), ComputeShader, PassParameters, FComputeShaderUtils::GetGroupCount(RenderExtent, FIntPoint(16, 16)));
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("CMAA2 DebugDrawEdges"), ComputeShader, PassParameters, State.DebugGroupCount);
 	}
 }
\ No newline at end of file
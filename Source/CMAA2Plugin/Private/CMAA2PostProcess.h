@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "PostProcess/PostProcessMaterial.h"
+#include "CMAA2Plugin.h"
 
 // Forward Declarations
 class FSceneView;
@@ -16,5 +17,6 @@ namespace CMAA2
 	extern int32 GPlacement;
 
 	// The main entry point for the CMAA2 render graph setup
-	void AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDGTextureRef Output);
+	// QualityMap is an optional texture as returned by FCMAA2QualityMapProvider. When null, r.CMAA2.QualityMap decides whether a foveation pattern is generated.
+	void AddCMAA2Pass(FRDGBuilder& GraphBuilder, const FSceneView& View, FRDGTextureRef Output, FRDGTextureRef QualityMap = nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+// Copyright 2025 Maksym Paziuk and contributors
+// Released under the MIT license https://opensource.org/license/MIT/
+
+#include "CMAA2PipelineState.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCMAA2UAVStoreConfigTest, "Plugins.CMAA2.UAVStoreConfig", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCMAA2UAVStoreConfigTest::RunTest(const FString& Parameters)
+{
+	CMAA2::FUAVStoreConfig Config;
+
+	// Typed float format
+	TestTrue(TEXT("FloatRGBA is supported"), CMAA2::ResolveUAVStoreConfig(PF_FloatRGBA, false, true, Config));
+	TestTrue(TEXT("FloatRGBA uses typed stores"), Config.bTyped);
+	TestFalse(TEXT("FloatRGBA stores float, not unorm"), Config.bTypedUnormFloat);
+	TestFalse(TEXT("FloatRGBA needs no sRGB conversion"), Config.bConvertToSRGB);
+	TestEqual(TEXT("FloatRGBA has no untyped format"), Config.UntypedFormat, 0);
+
+	// Untyped RGBA8 sRGB format
+	TestTrue(TEXT("R8G8B8A8 sRGB is supported"), CMAA2::ResolveUAVStoreConfig(PF_R8G8B8A8, true, false, Config));
+	TestFalse(TEXT("R8G8B8A8 sRGB uses untyped stores"), Config.bTyped);
+	TestTrue(TEXT("R8G8B8A8 sRGB converts to sRGB in the shader"), Config.bConvertToSRGB);
+	TestEqual(TEXT("R8G8B8A8 sRGB packs as R8G8B8A8"), Config.UntypedFormat, 1);
+
+	// Unsupported format
+	TestFalse(TEXT("G16R16F without typed stores is unsupported"), CMAA2::ResolveUAVStoreConfig(PF_G16R16F, false, false, Config));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCMAA2PipelineStateCacheTest, "Plugins.CMAA2.PipelineStateCache", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCMAA2PipelineStateCacheTest::RunTest(const FString& Parameters)
+{
+	CMAA2::FPipelineStateCache Cache;
+
+	CMAA2::FPipelineStateKey KeyA;
+	KeyA.Extent = FIntPoint(1920, 1080);
+	KeyA.Format = PF_R8G8B8A8;
+	KeyA.Quality = 2;
+
+	CMAA2::FPipelineStateKey KeyB = KeyA;
+	KeyB.Extent = FIntPoint(512, 512);
+
+	const CMAA2::FPipelineState& StateA = Cache.FindOrBuild(KeyA, 1);
+	TestEqual(TEXT("First use builds"), Cache.GetNumBuilds(), 1u);
+	TestTrue(TEXT("State keeps its key"), StateA.Key == KeyA);
+	TestEqual(TEXT("Edge texture is half width"), StateA.EdgesDesc.Extent, FIntPoint(960, 1080));
+
+	Cache.FindOrBuild(KeyA, 2);
+	TestEqual(TEXT("Unchanged key does not rebuild"), Cache.GetNumBuilds(), 1u);
+
+	Cache.FindOrBuild(KeyB, 2);
+	Cache.FindOrBuild(KeyA, 2);
+	Cache.FindOrBuild(KeyB, 2);
+	TestEqual(TEXT("Alternating views with different keys build each key once"), Cache.GetNumBuilds(), 2u);
+	TestEqual(TEXT("Both keys are cached"), Cache.Num(), 2);
+
+	CMAA2::FPipelineStateKey KeyC = KeyA;
+	KeyC.Quality = 3;
+	Cache.FindOrBuild(KeyC, 3);
+	TestEqual(TEXT("Changed CVar value rebuilds"), Cache.GetNumBuilds(), 3u);
+
+	Cache.FindOrBuild(KeyA, 10);
+	Cache.FindOrBuild(KeyA, 10 + CMAA2::FPipelineStateCache::MaxIdleFrames);
+	TestEqual(TEXT("Idle states are dropped"), Cache.Num(), 1);
+	TestEqual(TEXT("Recently used state is kept"), Cache.GetNumBuilds(), 3u);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -7,6 +7,21 @@
 #include "Modules/ModuleManager.h"
 #include "CMAA2Utils.h"
 
+// Forward Declarations
+class FRDGBuilder;
+class FRDGTexture;
+class FSceneView;
+
+namespace CMAA2
+{
+	// Size in pixels of one quality map tile; must be even
+	static constexpr int32 QualityMapTileSize = 16;
+}
+
+// Returns a PF_R8_UINT texture with one CMAA2 quality preset (0-3) per CMAA2::QualityMapTileSize tile of the view rect, e.g. converted
+// from an eye tracker or the variable rate shading image, or nullptr to fall back to r.CMAA2.QualityMap. Runs on the render thread.
+DECLARE_DELEGATE_RetVal_TwoParams(FRDGTexture*, FCMAA2QualityMapProvider, FRDGBuilder& /*GraphBuilder*/, const FSceneView& /*View*/);
+
 
 class FCMAA2PluginModule : public IModuleInterface
 {
@@ -14,6 +29,19 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+	static FCMAA2PluginModule& Get()
+	{
+		return FModuleManager::LoadModuleChecked<FCMAA2PluginModule>(TEXT("CMAA2Plugin"));
+	}
+
+	// Call from the game thread; pass an unbound delegate to remove the provider
+	CMAA2PLUGIN_API void SetQualityMapProvider(FCMAA2QualityMapProvider Provider);
+
+	const FCMAA2QualityMapProvider& GetQualityMapProvider_RenderThread() const
+	{
+		return QualityMapProvider_RenderThread;
+	}
+
 private:
 	void InitCMAA2ViewExtension();
 
@@ -24,5 +52,7 @@ private:
 	TSharedPtr<class FSceneViewExtensionBase> CMAA2ViewExtension;
 #endif
 
+	FCMAA2QualityMapProvider QualityMapProvider_RenderThread;
+
 	FDelegateHandle OnPostEngineInitDelegateHandle;
 };
\ No newline at end of file